@@ -1,22 +1,23 @@
 #include "sysy_builder.hpp"
 #include "logging.hpp"
 #include <stack>
+#include <algorithm>
 #include <cmath>
 
 #define CONST_FP(num) ConstantFP::get((float)num, module.get())
 #define CONST_INT(num) ConstantInt::get(num, module.get())
-// types
-Type *VOID_T;
+// types，直接从当前 module 获取，不再使用进程级的全局指针，同一进程内构建多个 module 时互不干扰
+#define VOID_T module->get_void_type()
 
-Type *INT1_T;
-Type *INT32_T;
-Type *INT8_T;
-Type *INT16_T;
-Type *INT64_T;
+#define INT1_T module->get_int1_type()
+#define INT32_T module->get_int32_type()
+#define INT8_T module->get_int8_type()
+#define INT16_T module->get_int16_type()
+#define INT64_T module->get_int64_type()
 
-Type *INT32PTR_T;
-Type *FLOAT_T;
-Type *FLOATPTR_T;
+#define INT32PTR_T module->get_int32_ptr_type()
+#define FLOAT_T module->get_float_type()
+#define FLOATPTR_T module->get_float_ptr_type()
 
 // 确保在运算过程中，左右操作数的类型一致，尤其是在整数和浮点数之间转换
 // 返回值
@@ -67,17 +68,6 @@ bool SysyBuilder::promote(Value **l_val_p, Value **r_val_p, const_val *l_num, co
 // CompUnit -> (CompUnit) Decl | FuncDef
 Value *SysyBuilder::visit(ASTProgram &node)
 {
-    //初始化类型信息，以便后续生成IR时获取
-    VOID_T = module->get_void_type();
-    INT1_T = module->get_int1_type();
-    INT8_T = module->get_int8_type();
-    INT16_T = module->get_int16_type();
-    INT32_T = module->get_int32_type();
-    INT64_T = module->get_int64_type();
-    INT32PTR_T = module->get_int32_ptr_type();
-    FLOAT_T = module->get_float_type();
-    FLOATPTR_T = module->get_float_ptr_type();
-
     Value *ret_val = nullptr;
     for (auto &comp : node.compunits) // 遍历 CompUnit 节点,不过在ast.cpp中经过flatten操作后，这里其实会直接执行对应传入ASTDecl或ASTFuncDef的visit方法
     {
@@ -235,11 +225,11 @@ Value *SysyBuilder::visit(ASTDef &node)
     auto current_type = context.type; //type在上一层（ASTDecl）处理的时候就存到context里了，因此可以直接获取
     if (current_type == TYPE_INT) // 确定常量/变量类型
     {
-        var_type = module->get_int32_type();
+        var_type = INT32_T;
     }
     else if (current_type == TYPE_FLOAT)
     {
-        var_type = module->get_float_type();
+        var_type = FLOAT_T;
     }
     else
     {
@@ -359,26 +349,36 @@ Value *SysyBuilder::visit(ASTDef &node)
                 auto initval = context.exp_vals; //获取处理好的初始化列表
                 auto var = builder->create_alloca(array_type); //分配数组空间
                 scope.push(node.id, var); //维护符号表
-                Value *temp = var;
-                int len = 1;
-                for (auto i : context.exp_lists)// 计算数组长度（总元素数）
-                {
-                    len *= i.val.i_val;
-                }
                 // 初始化零值（使用 memset 调用），假设int a[10] = {1, 2};则后续部分都将自动初始化为0，而逐个赋0比较麻烦，这里就调用memset
-                auto temp_dim = std::vector<Value *>(context.exp_lists.size() + 1, CONST_INT(0)); 
-                temp = builder->create_gep(temp, temp_dim);
-                if (current_type == TYPE_INT)
-                {
-                    auto mem_set = scope.find("memset_int");
-                    auto call = builder->create_call(mem_set, {temp, CONST_INT(len)});
-                    call->set_name("memset_int_call");
-                }
-                else
+                // 已由初始化列表赋值的元素无需清零：memset 只覆盖第一个到最后一个未初始化元素之间的范围，
+                // 若初始化列表覆盖了每一个元素，则直接省去 memset
+                auto first_zero = std::find(initval.begin(), initval.end(), nullptr);
+                if (first_zero != initval.end())
                 {
-                    auto mem_set = scope.find("memset_float");
-                    auto call = builder->create_call(mem_set, {temp, CONST_INT(len)});
-                    call->set_name("memset_float_call");
+                    auto last_zero = std::find(initval.rbegin(), initval.rend(), nullptr);
+                    unsigned int lo = first_zero - initval.begin(); // 第一个未初始化元素
+                    unsigned int hi = (initval.rend() - last_zero) - 1; // 最后一个未初始化元素
+                    std::vector<Value *> lo_dim_v(context.exp_lists.size() + 1, CONST_INT(0));
+                    auto temp = lo;
+                    for (auto dim = context.exp_lists.size(); dim > 0; --dim) // 计算起始元素的多维下标
+                    {
+                        lo_dim_v[dim] = CONST_INT(int(temp % context.exp_lists[dim - 1].val.i_val));
+                        temp /= context.exp_lists[dim - 1].val.i_val;
+                    }
+                    auto start = builder->create_gep(var, lo_dim_v);
+                    auto len = CONST_INT(int(hi - lo + 1));
+                    if (current_type == TYPE_INT)
+                    {
+                        auto mem_set = scope.find("memset_int");
+                        auto call = builder->create_call(mem_set, {start, len});
+                        call->set_name("memset_int_call");
+                    }
+                    else
+                    {
+                        auto mem_set = scope.find("memset_float");
+                        auto call = builder->create_call(mem_set, {start, len});
+                        call->set_name("memset_float_call");
+                    }
                 }
                 // 将初始值填入每一个具体位置
                 for (auto val = 0u; val < initval.size(); val++)
@@ -675,24 +675,85 @@ Value *SysyBuilder::visit(ASTSelectionStmt &node)//if else语句
     return nullptr;
 }
 
+// 将基本块移到所在函数基本块列表的末尾，只调整布局，不改变控制流
+static void move_to_end(Function *func, BasicBlock *bb)
+{
+    auto &bbs = func->get_basic_blocks();
+    bbs.remove(bb);
+    bbs.push_back(bb);
+}
+
 Value *SysyBuilder::visit(ASTIterationStmt &node) //while循环
 {
+    // while 循环按旋转后的形式（带守卫的 do-while）生成，条件判断放在循环体末尾，
+    // 每次迭代只需执行一次条件跳转，而不是“无条件跳回 condBB + 条件跳转”两次：
+    //   condBB:      Cond ? preheaderBB : nextBB   守卫，进入循环前判断一次
+    //   preheaderBB: br bodyBB                     唯一的循环入口
+    //   bodyBB:      Stmt; br latchBB
+    //   latchBB:     Cond ? bodyBB : exitBB        continue 跳转到这里
+    //   exitBB:      br nextBB                     break 跳转到这里，只有循环内的前驱
     auto *condBB = BasicBlock::create(module.get(), "", context.func);
     if (not builder->get_insert_block()->is_terminated())
     {
         builder->create_br(condBB);
     }
+    auto *preheaderBB = BasicBlock::create(module.get(), "", context.func);
+    auto *bodyBB = BasicBlock::create(module.get(), "", context.func);
+    auto *latchBB = BasicBlock::create(module.get(), "", context.func);
+    auto *exitBB = BasicBlock::create(module.get(), "", context.func);
+    auto *nextBB = BasicBlock::create(module.get(), "", context.func);
 
-    builder->set_insert_point(condBB);
-    //TODO:你需要处理while循环的控制流部分
-    //提示：
-    //      可参考if else语句的实现 Value *SysyBuilder::visit(ASTSelectionStmt &node)
-    //      不同的是while循环没有falseBB(条件错误时进入的基本块)，而是多了表示条件语句的condBB
-    //      具体可回顾预热实验中while_generator.cpp的实现
-    //      如果要处理while循环的条件语句，只需node.cond->accept(*this);
-    //      处理循环体的话，只需node.stmt->accept(*this); 注意考虑循环体为空的情况(node.stmt == nullptr)
+    builder->set_insert_point(condBB);// 守卫：条件不成立时直接跳过整个循环
+    context.true_bb_stk.push(preheaderBB);
+    context.false_bb_stk.push(nextBB);
+    node.cond->accept(*this);
+    context.true_bb_stk.pop();
+    context.false_bb_stk.pop();
+    // 守卫条件中 &&/|| 的短路中间块是在上面才创建的，排在最后；把 preheaderBB、bodyBB 移到它们之后，
+    // 避免这些只执行一次的块夹在循环体和 latchBB 之间
+    move_to_end(context.func, preheaderBB);
+    move_to_end(context.func, bodyBB);
+
+    builder->set_insert_point(preheaderBB);
+    builder->create_br(bodyBB);
+
+    builder->set_insert_point(bodyBB);// 循环体
+    context.cond_bb_stk.push(latchBB);// continue 的目标
+    context.next_bb_stk.push(exitBB);// break 的目标
+    if (node.stmt != nullptr)
+        node.stmt->accept(*this);
+    // 与 if else 语句相同：循环体末尾若是没有前驱的空块（如 if 两个分支都 return 后的 nextBB），直接删除，不让它连到 latchBB
+    if (builder->get_insert_block()->empty() && builder->get_insert_block()->get_pre_basic_blocks().empty())
+        builder->get_insert_block()->erase_from_parent();
+    else if (not builder->get_insert_block()->is_terminated())
+        builder->create_br(latchBB);
+    context.cond_bb_stk.pop();
+    context.next_bb_stk.pop();
 
-    //TODO-----------------------------------end
+    // latchBB、exitBB、nextBB 在处理循环体之前就已创建，循环体内新建的基本块（if、嵌套循环、&&/||）都排在它们后面，
+    // 这里把它们依次移到函数末尾，使循环体之后紧跟 latchBB，每次迭代只有回到 bodyBB 的一次跳转
+    if (latchBB->get_pre_basic_blocks().empty()) // 循环体总是 return/break 时，末尾的条件判断不可达，删除该块
+        latchBB->erase_from_parent();
+    else
+    {
+        move_to_end(context.func, latchBB);
+        builder->set_insert_point(latchBB);// 循环末尾再次判断条件，成立则回到循环体
+        context.true_bb_stk.push(bodyBB);
+        context.false_bb_stk.push(exitBB);
+        node.cond->accept(*this);
+        context.true_bb_stk.pop();
+        context.false_bb_stk.pop();
+    }
+    if (exitBB->get_pre_basic_blocks().empty())
+        exitBB->erase_from_parent();
+    else
+    {
+        move_to_end(context.func, exitBB);
+        builder->set_insert_point(exitBB);
+        builder->create_br(nextBB);
+    }
+    move_to_end(context.func, nextBB);
+    builder->set_insert_point(nextBB);
     return nullptr;
 }
 
@@ -705,11 +766,9 @@ Value *SysyBuilder::visit(ASTBreak &node)//break语句
 
 Value *SysyBuilder::visit(ASTContinue &node)//continue语句
 {
-    //TODO:你需要处理continue语句
-    //提示： 代码非常简单（只要2行）参考break语句的实现
-    //      你只需要思考下一个基本块去哪获取（context.next_bb_stk？context.true_bb_stk？context.false_bb_stk？还是context.cond_bb_stk？）
-    return nullptr;//这里是为了防止编译报错需要修改
-    //TODO------------------------end
+    auto *bb = context.cond_bb_stk.top();// 跳转到循环末尾的条件判断块
+    auto *ret_val = builder->create_br(bb);
+    return ret_val;
 }
 
 Value *SysyBuilder::visit(ASTReturnStmt &node)//return 语句
@@ -901,53 +960,42 @@ Value *SysyBuilder::visit(ASTNum &node)//Number
         return CONST_FP(node.f_val);
     }
 }
+// 跳过连续的一元 ! 和 +，统计其中 ! 的个数，返回其后的操作数
+static ASTUnaryExp *strip_logic_not(ASTUnaryExp &node, int &not_count)
+{
+    auto *cur = &node;
+    while (cur->unary_exp != nullptr && cur->unary_op != OP_MINUS)
+    {
+        if (cur->unary_op == OP_NOT)
+            not_count++;
+        cur = &*cur->unary_exp;
+    }
+    return cur;
+}
+// 若 EqExp 只是单个以 ! 开头的 UnaryExp（中间没有任何二元运算符），返回该 UnaryExp，否则返回 nullptr
+static ASTUnaryExp *as_logic_not(ASTEqExp &node)
+{
+    if (node.eq_exp != nullptr || node.rel_exp->rel_exp != nullptr)
+        return nullptr;
+    auto &add_exp = *node.rel_exp->add_exp;
+    if (add_exp.add_exp != nullptr || add_exp.mul_exp->mul_exp != nullptr)
+        return nullptr;
+    auto &unary_exp = *add_exp.mul_exp->unary_exp;
+    if (unary_exp.unary_exp == nullptr || unary_exp.unary_op != OP_NOT)
+        return nullptr;
+    return &unary_exp;
+}
 //一元表达式 UnaryExp → PrimaryExp | Ident '(' [FuncRParams] ')'
 //                   | UnaryOp UnaryExp
 Value *SysyBuilder::visit(ASTUnaryExp &node)
 {
     if (node.call_exp != nullptr)//函数调用 UnaryExp → Ident '(' [FuncRParams] ')'
     {
-        Value *ret_val;
-        if (!context.logic_op) //当前的UnaryExp处在一个逻辑反的上下文中
-        {
-            context.logic_op = true;//暂时设置 logic_op = true 避免函数调用的处理
-            ret_val = node.call_exp->accept(*this);
-            context.logic_op = false; //恢复逻辑反的上下文
-        }
-        else
-            ret_val = node.call_exp->accept(*this);
-        if (!context.logic_op)//处理逻辑反上下文
-        {
-            if (ret_val->get_type()->is_integer_type())
-                ret_val = builder->create_icmp_eq(CONST_INT(0), ret_val);//返回反向布尔值
-            else
-                ret_val = builder->create_fcmp_eq(CONST_FP(0.), ret_val);
-            ret_val = builder->create_zext(ret_val, INT32_T);
-            context.logic_op = true;//消除了逻辑反上下文
-        }
-        return ret_val;
+        return node.call_exp->accept(*this);
     }
     if (node.primary_exp != nullptr)//UnaryExp → PrimaryExp
     {
-        Value *ret_val;
-        if (!context.logic_op)
-        {
-            context.logic_op = true;
-            ret_val = node.primary_exp->accept(*this);
-            context.logic_op = false;
-        }
-        else
-            ret_val = node.primary_exp->accept(*this);
-        if (!context.logic_op)
-        {
-            if (ret_val->get_type()->is_integer_type())
-                ret_val = builder->create_icmp_eq(CONST_INT(0), ret_val);
-            else
-                ret_val = builder->create_fcmp_eq(CONST_FP(0.), ret_val);
-            ret_val = builder->create_zext(ret_val, INT32_T);
-            context.logic_op = true;
-        }
-        return ret_val;
+        return node.primary_exp->accept(*this);
     }
     if (node.unary_exp != nullptr) //UnaryExp -> UnaryOp UnaryExp
     {
@@ -984,7 +1032,26 @@ Value *SysyBuilder::visit(ASTUnaryExp &node)
         }
         else if (node.unary_op == OP_NOT)//UnaryOP -> !
         {
-            context.logic_op = (!context.logic_op); // 将当前上下文的逻辑取反
+            // 连续的 ! 一并处理：奇数个 ! 即 x == 0，偶数个即 x != 0（!!x 的值是 0 或 1，而不是 x 本身）
+            Value *ret_val = nullptr;
+            int not_count = 0;
+            auto *exp_val = strip_logic_not(node, not_count)->accept(*this);//处理 ! 后面的UnaryExp
+            bool is_zero_test = (not_count % 2 == 1);
+            if (exp_val->get_type()->is_integer_type())
+                context.val.i_val = is_zero_test ? (context.val.i_val == 0) : (context.val.i_val != 0);
+            else
+                context.val.i_val = is_zero_test ? (context.val.f_val == 0) : (context.val.f_val != 0);
+            if (context.is_const_exp || scope.in_global())
+                ret_val = CONST_INT((int)context.val.i_val);
+            else
+            {
+                if (exp_val->get_type()->is_integer_type())// 常量统一放在右侧
+                    ret_val = is_zero_test ? builder->create_icmp_eq(exp_val, CONST_INT(0)) : builder->create_icmp_ne(exp_val, CONST_INT(0));
+                else
+                    ret_val = is_zero_test ? builder->create_fcmp_eq(exp_val, CONST_FP(0.)) : builder->create_fcmp_ne(exp_val, CONST_FP(0.));
+                ret_val = builder->create_zext(ret_val, INT32_T);// 结果作为 int 值参与后续运算
+            }
+            return ret_val;
         }
         else
         {
@@ -1002,59 +1069,69 @@ Value *SysyBuilder::visit(ASTAddExp &node)
         return node.mul_exp->accept(*this);//继续处理MulExp
     }
     //AddExp → AddExp ('+' | '−') MulExp
-    const_val l_num, r_num;// 用于存储左右操作数的值
-    auto *l_val = node.add_exp->accept(*this);//处理AddExp 左操作数
-    if (l_val->get_type()->is_integer_type())
-        l_num.i_val = context.val.i_val;
-    else
-        l_num.f_val = context.val.f_val;
-    auto *r_val = node.mul_exp->accept(*this);//处理MulExp 右操作数
-    if (r_val->get_type()->is_integer_type())
-        r_num.i_val = context.val.i_val;
-    else
-        r_num.f_val = context.val.f_val;
-    bool is_int = promote(&l_val, &r_val, &l_num, &r_num);// 调用 promote 函数进行类型提升，确保两个操作数的类型一致
-    Value *ret_val = nullptr; // 存储最终的计算结果
-    switch (node.op)
+    // 左递归链可能非常深（机器生成的代码里会有上万个连续的 +），逐层递归会耗尽栈
+    // 因此先沿左侧链收集节点，再自底向上迭代求值，生成的 IR 与递归写法完全一致
+    std::vector<ASTAddExp *> chain;
+    for (auto *cur = &node; cur->add_exp != nullptr; cur = &*cur->add_exp)
+        chain.push_back(cur);
+    auto *l_val = chain.back()->add_exp->accept(*this);//处理最左侧的操作数
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it)
     {
-    case OP_ADD://加法
-        if (is_int)
-        {
-            context.val.i_val = l_num.i_val + r_num.i_val;// 计算整数相加的结果，方便上层获取
-            if (context.is_const_exp)
-                ret_val = CONST_INT((int)context.val.i_val);
-            else
-                ret_val = builder->create_iadd(l_val, r_val);
-        }
+        auto &cur = **it;
+        const_val l_num, r_num;// 用于存储左右操作数的值
+        if (l_val->get_type()->is_integer_type())
+            l_num.i_val = context.val.i_val;
         else
-        {
-            context.val.f_val = l_num.f_val + r_num.f_val; // 计算浮点数相加的结果，方便上层获取
-            if (context.is_const_exp)
-                ret_val = CONST_FP(context.val.f_val);
-            else
-                ret_val = builder->create_fadd(l_val, r_val);
-        }
-        break;
-    case OP_SUB://减法
-        if (is_int)
-        {
-            context.val.i_val = l_num.i_val - r_num.i_val;
-            if (context.is_const_exp)
-                ret_val = CONST_INT((int)context.val.i_val);
-            else
-                ret_val = builder->create_isub(l_val, r_val);
-        }
+            l_num.f_val = context.val.f_val;
+        auto *r_val = cur.mul_exp->accept(*this);//处理MulExp 右操作数
+        if (r_val->get_type()->is_integer_type())
+            r_num.i_val = context.val.i_val;
         else
+            r_num.f_val = context.val.f_val;
+        bool is_int = promote(&l_val, &r_val, &l_num, &r_num);// 调用 promote 函数进行类型提升，确保两个操作数的类型一致
+        Value *ret_val = nullptr; // 存储最终的计算结果
+        switch (cur.op)
         {
-            context.val.f_val = l_num.f_val - r_num.f_val;
-            if (context.is_const_exp)
-                ret_val = CONST_FP(context.val.f_val);
+        case OP_ADD://加法
+            if (is_int)
+            {
+                context.val.i_val = l_num.i_val + r_num.i_val;// 计算整数相加的结果，方便上层获取
+                if (context.is_const_exp)
+                    ret_val = CONST_INT((int)context.val.i_val);
+                else
+                    ret_val = builder->create_iadd(l_val, r_val);
+            }
+            else
+            {
+                context.val.f_val = l_num.f_val + r_num.f_val; // 计算浮点数相加的结果，方便上层获取
+                if (context.is_const_exp)
+                    ret_val = CONST_FP(context.val.f_val);
+                else
+                    ret_val = builder->create_fadd(l_val, r_val);
+            }
+            break;
+        case OP_SUB://减法
+            if (is_int)
+            {
+                context.val.i_val = l_num.i_val - r_num.i_val;
+                if (context.is_const_exp)
+                    ret_val = CONST_INT((int)context.val.i_val);
+                else
+                    ret_val = builder->create_isub(l_val, r_val);
+            }
             else
-                ret_val = builder->create_fsub(l_val, r_val);
+            {
+                context.val.f_val = l_num.f_val - r_num.f_val;
+                if (context.is_const_exp)
+                    ret_val = CONST_FP(context.val.f_val);
+                else
+                    ret_val = builder->create_fsub(l_val, r_val);
+            }
+            break;
         }
-        break;
+        l_val = ret_val;// 当前结果作为外层运算的左操作数
     }
-    return ret_val;
+    return l_val;
 }
 // MulExp → UnaryExp | MulExp ('*' | '/' | '%') UnaryExp
 Value *SysyBuilder::visit(ASTMulExp &node)
@@ -1064,81 +1141,91 @@ Value *SysyBuilder::visit(ASTMulExp &node)
         return node.unary_exp->accept(*this);
     }
     //MulExp → MulExp ('*' | '/' | '%') UnaryExp
-    const_val l_num, r_num;//左右操作数
-    auto *l_val = node.mul_exp->accept(*this);//处理MulExp 左操作数
-    if (l_val->get_type()->is_integer_type())
-        l_num.i_val = context.val.i_val;
-    else
-        l_num.f_val = context.val.f_val;
-    auto *r_val = node.unary_exp->accept(*this);//处理UnaryExp 右操作数
-    if (r_val->get_type()->is_integer_type())
-        r_num.i_val = context.val.i_val;
-    else
-        r_num.f_val = context.val.f_val;
-    bool is_int = promote(&l_val, &r_val, &l_num, &r_num);// 调用 promote 函数进行类型提升，确保两个操作数的类型一致
-    Value *ret_val = nullptr;
-    switch (node.op)
+    // 左递归链可能非常深（机器生成的代码里会有上万个连续的 *），逐层递归会耗尽栈
+    // 因此先沿左侧链收集节点，再自底向上迭代求值，生成的 IR 与递归写法完全一致
+    std::vector<ASTMulExp *> chain;
+    for (auto *cur = &node; cur->mul_exp != nullptr; cur = &*cur->mul_exp)
+        chain.push_back(cur);
+    auto *l_val = chain.back()->mul_exp->accept(*this);//处理最左侧的操作数
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it)
     {
-    case OP_MUL:
-        if (is_int)
-        {
-            context.val.i_val = l_num.i_val * r_num.i_val;
-            if (context.is_const_exp)
-                ret_val = CONST_INT((int)context.val.i_val);
-            else
-                ret_val = builder->create_imul(l_val, r_val);
-        }
+        auto &cur = **it;
+        const_val l_num, r_num;// 用于存储左右操作数的值
+        if (l_val->get_type()->is_integer_type())
+            l_num.i_val = context.val.i_val;
         else
+            l_num.f_val = context.val.f_val;
+        auto *r_val = cur.unary_exp->accept(*this);//处理UnaryExp 右操作数
+        if (r_val->get_type()->is_integer_type())
+            r_num.i_val = context.val.i_val;
+        else
+            r_num.f_val = context.val.f_val;
+        bool is_int = promote(&l_val, &r_val, &l_num, &r_num);// 调用 promote 函数进行类型提升，确保两个操作数的类型一致
+        Value *ret_val = nullptr;
+        switch (cur.op)
         {
-            context.val.f_val = l_num.f_val * r_num.f_val;
-            if (context.is_const_exp)
-                ret_val = CONST_FP(context.val.f_val);
+        case OP_MUL:
+            if (is_int)
+            {
+                context.val.i_val = l_num.i_val * r_num.i_val;
+                if (context.is_const_exp)
+                    ret_val = CONST_INT((int)context.val.i_val);
+                else
+                    ret_val = builder->create_imul(l_val, r_val);
+            }
             else
-                ret_val = builder->create_fmul(l_val, r_val);
-        }
-        break;
-    case OP_DIV:
-        if (is_int)
-        {
-            if (r_num.i_val == 0) {
-                std::abort();
+            {
+                context.val.f_val = l_num.f_val * r_num.f_val;
+                if (context.is_const_exp)
+                    ret_val = CONST_FP(context.val.f_val);
+                else
+                    ret_val = builder->create_fmul(l_val, r_val);
+            }
+            break;
+        case OP_DIV:
+            if (is_int)
+            {
+                if (r_num.i_val == 0) {
+                    std::abort();
+                }
+                context.val.i_val = l_num.i_val / r_num.i_val;
+                if (context.is_const_exp)
+                    ret_val = CONST_INT((int)context.val.i_val);
+                else
+                    ret_val = builder->create_isdiv(l_val, r_val);
             }
-            context.val.i_val = l_num.i_val / r_num.i_val;
-            if (context.is_const_exp)
-                ret_val = CONST_INT((int)context.val.i_val);
             else
-                ret_val = builder->create_isdiv(l_val, r_val);
-        }
-        else
-        {
-            context.val.f_val = l_num.f_val / r_num.f_val;
-            if (context.is_const_exp)
-                ret_val = CONST_FP(context.val.f_val);
+            {
+                context.val.f_val = l_num.f_val / r_num.f_val;
+                if (context.is_const_exp)
+                    ret_val = CONST_FP(context.val.f_val);
+                else
+                    ret_val = builder->create_fdiv(l_val, r_val);
+            }
+            break;
+        case OP_MOD:
+            if (is_int)
+            {
+                if (r_num.i_val == 0) {
+                    std::abort();
+                }
+                context.val.i_val = l_num.i_val % r_num.i_val;
+                if (context.is_const_exp)
+                    ret_val = CONST_INT((int)context.val.i_val);
+                else
+                    ret_val = builder->create_srem(l_val, r_val);
+            }
             else
-                ret_val = builder->create_fdiv(l_val, r_val);
-        }
-        break;
-    case OP_MOD:
-        if (is_int)
-        {
-            if (r_num.i_val == 0) {
+            {
+                std::cerr << "浮点数没有取余操作（%）" << std::endl;
                 std::abort();
             }
-            context.val.i_val = l_num.i_val % r_num.i_val;
-            if (context.is_const_exp)
-                ret_val = CONST_INT((int)context.val.i_val);
-            else
-                ret_val = builder->create_srem(l_val, r_val);
-        }
-        else
-        {
-            std::cerr << "浮点数没有取余操作（%）" << std::endl;
-            std::abort();
+            break;
         }
-        break;
+        l_val = ret_val;// 当前结果作为外层运算的左操作数
     }
     //TODO------------------------------end
-    return ret_val;
+    return l_val;
 }
 // RelExp → AddExp | RelExp ('<' | '>' | '<=' | '>=') AddExp
 Value *SysyBuilder::visit(ASTRelExp &node)
@@ -1326,37 +1413,59 @@ Value *SysyBuilder::visit(ASTLAndExp &node)
     Value *ret_val = nullptr;
     auto *true_bb = context.true_bb_stk.top();
     auto *false_bb = context.false_bb_stk.top();
+    // 处理 EqExp 并将其值转为 i1 条件
+    auto to_cond = [&](ASTEqExp &exp) -> Value * {
+        auto *not_exp = as_logic_not(exp);
+        if (not_exp != nullptr) // 条件本身就是 !x：直接生成比较，不必先 zext 成 int32 再与 0 比较
+        {
+            int not_count = 0;
+            auto *val = strip_logic_not(*not_exp, not_count)->accept(*this);
+            bool is_zero_test = (not_count % 2 == 1);
+            if (val->get_type()->is_integer_type())
+                return is_zero_test ? builder->create_icmp_eq(val, CONST_INT(0)) : builder->create_icmp_ne(val, CONST_INT(0));
+            return is_zero_test ? builder->create_fcmp_eq(val, CONST_FP(0.)) : builder->create_fcmp_ne(val, CONST_FP(0.));
+        }
+        auto *val = exp.accept(*this);
+        if (val->get_type()->is_int32_type())// 若返回值为 int32 类型，生成与 0 的比较，不等于 0 表示 true
+            return builder->create_icmp_ne(val, CONST_INT(0));
+        if (val->get_type()->is_float_type()) // 若返回值为浮点类型，使用浮点不等于 0.0 来判断真假
+            return builder->create_fcmp_ne(val, CONST_FP(0.));
+        return val;
+    };
     if (node.land_exp == nullptr)//LAndExp → EqExp
     {
-        ret_val = node.eq_exp->accept(*this);
-        if (ret_val->get_type()->is_int32_type())// 若返回值为 int32 类型，生成与 0 的比较，不等于 0 表示 true
-            ret_val = builder->create_icmp_ne(CONST_INT(0), ret_val);
-        else if (ret_val->get_type()->is_float_type()) // 若返回值为浮点类型，使用浮点不等于 0.0 来判断真假
-            ret_val = builder->create_fcmp_ne(CONST_FP(0.), ret_val);
+        ret_val = to_cond(*node.eq_exp);
         ret_val = builder->create_cond_br(ret_val, true_bb, false_bb);
         return ret_val;// 返回的是分支跳转指令
     }
     // LAndExp -> LAndExp && EqExp
-    auto *mid_bb = BasicBlock::create(module.get(), "", context.func);// 短路中间节点
-    // 将中间块压入 true 分支栈，false 分支保持不变
-    context.true_bb_stk.push(mid_bb);
+    // 与 AddExp 相同，沿左侧链迭代处理，避免超长的 && 链递归过深
+    // chain 自顶向下保存各层节点，mid_bbs[i] 是 chain[i] 的短路中间节点（左侧为 true 时进入）
+    std::vector<ASTLAndExp *> chain;
+    std::vector<BasicBlock *> mid_bbs;
+    for (auto *cur = &node; cur->land_exp != nullptr; cur = &*cur->land_exp)
+    {
+        chain.push_back(cur);
+        mid_bbs.push_back(BasicBlock::create(module.get(), "", context.func));// 短路中间节点，创建顺序与递归写法一致
+    }
+    // 最左侧的 EqExp：为 true 时进入最内层的中间块，否则直接跳 false_bb
+    context.true_bb_stk.push(mid_bbs.back());
     context.false_bb_stk.push(false_bb);
-    // 递归处理左侧 LAndExp，逻辑上只要左边为 false 就可以直接跳 false_bb
-    auto *l_val = node.land_exp->accept(*this);
-    // 弹出栈，恢复现场
+    chain.back()->land_exp->accept(*this);
     context.true_bb_stk.pop();
     context.false_bb_stk.pop();
-    if (not builder->get_insert_block()->is_terminated())// 如果左侧生成的 block 没有终止（还未跳转），则创建跳转指令
-        builder->create_cond_br(l_val, mid_bb, false_bb);
-
-    builder->set_insert_point(mid_bb);// 设置 IR 生成的插入点为中间块，表示左边 LAndExp为 true 的情况下进入右边判断
-    auto *r_val = node.eq_exp->accept(*this);// 处理右侧 EqExp 
-    if (r_val->get_type()->is_int32_type())
-        r_val = builder->create_icmp_ne(CONST_INT(0), r_val);// 将 EqExp 的值转为布尔值：int32 类型不等于 0
-    else if (r_val->get_type()->is_float_type())
-        r_val = builder->create_fcmp_ne(CONST_FP(0.), r_val);// 或者浮点不等于 0.0
-    builder->create_cond_br(r_val, true_bb, false_bb);// 若右边EqExp为 true 则跳转 true_bb，否则跳 false_bb
-    return nullptr;
+    for (auto i = chain.size(); i-- > 0;)
+    {
+        auto *next_true_bb = (i == 0) ? true_bb : mid_bbs[i - 1];// 外层还有 && 时，为 true 继续进入外层的中间块
+        builder->set_insert_point(mid_bbs[i]);// 设置 IR 生成的插入点为中间块，表示左边 LAndExp为 true 的情况下进入右边判断
+        context.true_bb_stk.push(next_true_bb);
+        context.false_bb_stk.push(false_bb);
+        auto *r_val = to_cond(*chain[i]->eq_exp);// 处理右侧 EqExp，并将其值转为布尔值
+        context.true_bb_stk.pop();
+        context.false_bb_stk.pop();
+        builder->create_cond_br(r_val, next_true_bb, false_bb);// 若右边EqExp为 true 则跳转，否则跳 false_bb
+    }
+    return ret_val;
 }
 //Cond → LOrExp
 //LOrExp → LAndExp | LOrExp '||' LAndExp
@@ -1374,28 +1483,37 @@ Value *SysyBuilder::visit(ASTLOrExp &node)//LOrExp是比LAndExp更上层的存
         context.false_bb_stk.pop();
         return nullptr;
     }
-    // 短路中间节点
-    auto *mid_bb = BasicBlock::create(module.get(), "", context.func);
     // LOrExp -> LOrExp '||' LAndExp
-    // 左侧布尔表达式LOrExp 
-    context.true_bb_stk.push(true_bb);
-    context.false_bb_stk.push(mid_bb);
-    node.lor_exp->accept(*this);
-    context.true_bb_stk.pop();
-    context.false_bb_stk.pop();
-    builder->set_insert_point(mid_bb);
-    // 右侧布尔表达式LAndExp
+    // 沿左侧链迭代处理，mid_bbs[i] 是 chain[i] 左侧为 false 时进入的短路中间节点
+    std::vector<ASTLOrExp *> chain;
+    std::vector<BasicBlock *> mid_bbs;
+    for (auto *cur = &node; cur->lor_exp != nullptr; cur = &*cur->lor_exp)
+    {
+        chain.push_back(cur);
+        mid_bbs.push_back(BasicBlock::create(module.get(), "", context.func));
+    }
+    // 最左侧布尔表达式
     context.true_bb_stk.push(true_bb);
-    context.false_bb_stk.push(false_bb);
-    node.land_exp->accept(*this);
+    context.false_bb_stk.push(mid_bbs.back());
+    chain.back()->lor_exp->accept(*this);
     context.true_bb_stk.pop();
     context.false_bb_stk.pop();
+    for (auto i = chain.size(); i-- > 0;)
+    {
+        builder->set_insert_point(mid_bbs[i]);
+        // 右侧布尔表达式LAndExp，为 false 时进入外层的中间块（最外层则进入 false_bb）
+        context.true_bb_stk.push(true_bb);
+        context.false_bb_stk.push((i == 0) ? false_bb : mid_bbs[i - 1]);
+        chain[i]->land_exp->accept(*this);
+        context.true_bb_stk.pop();
+        context.false_bb_stk.pop();
+    }
     return nullptr;
 }
 
 Value *SysyBuilder::visit(ASTCall &node)//函数调用
 {
-    auto *func = dynamic_cast<Function *>(scope.find(node.id));//从符号表中查找调用的函数名 node.id 并转型为 Function* 类型
+    auto *func = static_cast<Function *>(scope.find(node.id));//从符号表中查找调用的函数名 node.id，语义上一定是 Function，无需 dynamic_cast
     std::vector<Value *> args;//存放函数实参
     // 获取函数参数类型的起始迭代器，用于逐个参数与传入实参类型对比并处理类型转换
     auto param_type = func->get_function_type()->param_begin();
@@ -1420,7 +1538,7 @@ Value *SysyBuilder::visit(ASTCall &node)//函数调用
         args.push_back(arg_val);//把处理后的实参 IR 值加入参数列表
         param_type++;//推进到下一个函数参数类型
     }
-    auto *ret_val = builder->create_call(static_cast<Function *>(func), args);
+    auto *ret_val = builder->create_call(func, args);
 
     return ret_val;
 }